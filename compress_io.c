@@ -0,0 +1,138 @@
+/* popen / pclose, dup / dup2 and SIGPIPE are POSIX, not ANSI */
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include "compress_io.h"
+
+/* streams opened with popen, they have to be closed with pclose */
+static FILE *pipes[MAX_STREAMS];
+
+static int ends_with(const char *s, const char *suffix) {
+    size_t s_length = strlen(s);
+    size_t suffix_length = strlen(suffix);
+    return s_length >= suffix_length && strcmp(s + s_length - suffix_length, suffix) == 0;
+}
+
+/* Remember a popen-ed stream for close_stream */
+static FILE *track_pipe(FILE *stream) {
+    int i = 0;
+    if (stream == NULL) {
+        return NULL;
+    }
+    for (i = 0; i < MAX_STREAMS; i++) {
+        if (pipes[i] == NULL) {
+            pipes[i] = stream;
+            return stream;
+        }
+    }
+    pclose(stream);
+    return NULL;
+}
+
+/* Run "tool < path" through the shell with path single quoted */
+static FILE *open_input_pipe(const char *tool, const char *path) {
+    char *command = (char *) malloc(strlen(tool) + strlen(path) * 4 + 8);
+    char *p;
+    FILE *stream;
+    void (*previous)(int);
+
+    sprintf(command, "%s < '", tool);
+    p = command + strlen(command);
+    for (; *path != '\0'; path++) {
+        if (*path == '\'') {
+            strcpy(p, "'\\''");
+            p += 4;
+        } else {
+            *p++ = *path;
+        }
+    }
+    strcpy(p, "'");
+
+    fflush(NULL);
+    /* the decompressor must not inherit an ignored SIGPIPE from an output pipe */
+    previous = signal(SIGPIPE, SIG_DFL);
+    stream = popen(command, "r");
+    signal(SIGPIPE, previous);
+    free(command);
+    return track_pipe(stream);
+}
+
+/*
+ * Start tool with file as its stdout. The file is created here, so a path that cannot be written
+ * fails before anything runs. SIGPIPE is ignored from then on: if the compressor dies, writes fail
+ * with EPIPE and close_stream reports it instead of the process being killed.
+ */
+static FILE *open_output_pipe(const char *tool, FILE *file) {
+    FILE *stream;
+    int saved_stdout;
+
+    fflush(NULL);
+    saved_stdout = dup(STDOUT_FILENO);
+    if (saved_stdout == -1) {
+        fclose(file);
+        return NULL;
+    }
+    if (dup2(fileno(file), STDOUT_FILENO) == -1) {
+        close(saved_stdout);
+        fclose(file);
+        return NULL;
+    }
+    fclose(file);
+    stream = popen(tool, "w");
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+    if (stream != NULL) {
+        signal(SIGPIPE, SIG_IGN);
+    }
+    return track_pipe(stream);
+}
+
+FILE *open_input(const char *path) {
+    unsigned char magic[4] = {0, 0, 0, 0};
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+    fread(magic, 1, 4, file);
+    fclose(file);
+
+    if (magic[0] == 0x1F && magic[1] == 0x8B) {
+        return open_input_pipe("gzip -dc", path);
+    }
+    if (magic[0] == 0x28 && magic[1] == 0xB5 && magic[2] == 0x2F && magic[3] == 0xFD) {
+        return open_input_pipe("zstd -dcq", path);
+    }
+    return fopen(path, "r");
+}
+
+FILE *open_output(const char *path, const char *mode) {
+    FILE *file = fopen(path, ends_with(path, ".gz") || ends_with(path, ".zst") ? "wb" : mode);
+    if (file == NULL) {
+        return NULL;
+    }
+    if (ends_with(path, ".gz")) {
+        return open_output_pipe("gzip -c", file);
+    }
+    if (ends_with(path, ".zst")) {
+        return open_output_pipe("zstd -cq", file);
+    }
+    return file;
+}
+
+/* Returns non zero when the stream or its (de)compressor failed */
+int close_stream(FILE *stream) {
+    int i = 0;
+    /* a write error (e.g. EPIPE) would otherwise be lost when the buffer is already flushed */
+    int failed = ferror(stream);
+    for (i = 0; i < MAX_STREAMS; i++) {
+        if (pipes[i] == stream) {
+            pipes[i] = NULL;
+            return (pclose(stream) != 0) | failed;
+        }
+    }
+    return (fclose(stream) != 0) | failed;
+}
@@ -0,0 +1,27 @@
+/* compress_io.h*/
+
+#ifndef COMPRESS_IO_H
+#define COMPRESS_IO_H
+
+#include <stdio.h>
+
+#define MAX_STREAMS 16
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * gzip / zstd input is recognised by its magic bytes and output by its extension (.gz / .zst).
+ * Compressed streams run through gzip or zstd in a child process connected by a pipe,
+ * so (de)compression overlaps with parsing and nothing is written to a temporary file.
+ * Close every stream opened here with close_stream.
+ */
+FILE *open_input(const char *path);
+FILE *open_output(const char *path, const char *mode);
+int close_stream(FILE *stream);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -1,10 +1,15 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
+#include <errno.h>
 #include "part1.h"
+#include "compress_io.h"
 
+/* part1 keeps the table it read in these, see read_csv */
 int num_columns = 0;
 int num_lines = 0;
+ColType *col_types = NULL;
 
 void strip(char *s) {
     char *p2 = s;
@@ -18,146 +23,687 @@ void strip(char *s) {
     *p2 = '\0';
 }
 
+/* Returns 1 for true, 0 for false and -1 if s is not a boolean (case insensitive) */
+static int parse_bool(const char *s) {
+    const char *word;
+    int value;
+    if (tolower((unsigned char) s[0]) == 't') {
+        word = "true";
+        value = 1;
+    } else {
+        word = "false";
+        value = 0;
+    }
+    while (*word != '\0' && tolower((unsigned char) *s) == *word) {
+        word++;
+        s++;
+    }
+    return (*word == '\0' && *s == '\0') ? value : -1;
+}
+
+/* Classify a single cell, numbers have to follow the JSON grammar so they can be written unquoted */
+ColType classify_cell(const char *s) {
+    const char *p = s;
+    int is_float = 0;
+    if (parse_bool(s) != -1) {
+        return COL_BOOL;
+    }
+    if (*p == '-') {
+        p++;
+    }
+    if (!isdigit((unsigned char) *p)) {
+        return COL_STRING;
+    }
+    /* leading zeros (e.g. postal codes) are not JSON numbers */
+    if (*p == '0' && isdigit((unsigned char) p[1])) {
+        return COL_STRING;
+    }
+    while (isdigit((unsigned char) *p)) {
+        p++;
+    }
+    if (*p == '.') {
+        p++;
+        if (!isdigit((unsigned char) *p)) {
+            return COL_STRING;
+        }
+        while (isdigit((unsigned char) *p)) {
+            p++;
+        }
+        is_float = 1;
+    }
+    if (*p == 'e' || *p == 'E') {
+        p++;
+        if (*p == '+' || *p == '-') {
+            p++;
+        }
+        if (!isdigit((unsigned char) *p)) {
+            return COL_STRING;
+        }
+        while (isdigit((unsigned char) *p)) {
+            p++;
+        }
+        is_float = 1;
+    }
+    if (*p != '\0') {
+        return COL_STRING;
+    }
+    if (!is_float) {
+        /* integers that do not fit into a long are kept as floats */
+        errno = 0;
+        strtol(s, NULL, 10);
+        return errno == ERANGE ? COL_FLOAT : COL_INT;
+    }
+    return COL_FLOAT;
+}
+
+/* Full scan over every row, a column keeps the most specific type all of its non empty cells agree on */
+void infer_column_types(CsvRow **rows) {
+    int i = 0;
+    int j = 0;
+    col_types = (ColType *) malloc(num_columns * sizeof(ColType));
+    for (j = 0; j < num_columns; j++) {
+        /* an empty cell is a missing value, it does not take part in the inference */
+        int seen = 0;
+        col_types[j] = COL_STRING;
+        for (i = 0; i < num_lines; i++) {
+            ColType cell;
+            if (rows[i]->csv_data[j * 2 + 1][0] == '\0') {
+                continue;
+            }
+            cell = classify_cell(rows[i]->csv_data[j * 2 + 1]);
+            if (!seen || cell == col_types[j]) {
+                col_types[j] = cell;
+            } else if ((cell == COL_INT || cell == COL_FLOAT) &&
+                       (col_types[j] == COL_INT || col_types[j] == COL_FLOAT)) {
+                col_types[j] = COL_FLOAT;
+            } else {
+                col_types[j] = COL_STRING;
+            }
+            seen = 1;
+            if (col_types[j] == COL_STRING) {
+                break;
+            }
+        }
+    }
+}
+
+/* Missing value: an empty cell in a typed column, string columns keep "" */
+static int is_null_cell(const char *cell, ColType type) {
+    return type != COL_STRING && cell[0] == '\0';
+}
+
+/* Write s as a quoted JSON string at out, returns the new end of out */
+static char *put_json_string(char *out, const char *s) {
+    static const char hex[] = "0123456789abcdef";
+    *out++ = '"';
+    for (; *s != '\0'; s++) {
+        unsigned char c = (unsigned char) *s;
+        if (c == '"' || c == '\\') {
+            *out++ = '\\';
+            *out++ = (char) c;
+        } else if (c == '\n') {
+            *out++ = '\\';
+            *out++ = 'n';
+        } else if (c == '\r') {
+            *out++ = '\\';
+            *out++ = 'r';
+        } else if (c == '\t') {
+            *out++ = '\\';
+            *out++ = 't';
+        } else if (c < 0x20) {
+            sprintf(out, "\\u00%c%c", hex[c >> 4], hex[c & 0xF]);
+            out += 6;
+        } else {
+            *out++ = (char) c;
+        }
+    }
+    *out++ = '"';
+    return out;
+}
+
 char *csv_row_to_json(CsvRow *row) {
-    char *json = (char *) malloc(MAX_SIZE * sizeof(char));
+    char *json;
+    char *p;
+    size_t size = 8;
     int i = 0;
-    sprintf(json, "\t{\n");
+    /* escaping grows a byte to at most 6 (\u00XX) */
+    for (i = 0; i < num_columns; i++) {
+        size += 6 * (strlen(row->csv_data[i * 2]) + strlen(row->csv_data[i * 2 + 1])) + 16;
+    }
+    json = (char *) malloc(size);
+    p = json;
+    p += sprintf(p, "\t{\n");
     for (i = 0; i < num_columns; i++) {
-        sprintf(json + strlen(json), "\t\t\"%s\" : \"%s\"", row->csv_data[i * 2], row->csv_data[i * 2 + 1]);
+        p += sprintf(p, "\t\t");
+        p = put_json_string(p, row->csv_data[i * 2]);
+        p += sprintf(p, " : ");
+        if (col_types[i] == COL_STRING) {
+            p = put_json_string(p, row->csv_data[i * 2 + 1]);
+        } else if (is_null_cell(row->csv_data[i * 2 + 1], col_types[i])) {
+            p += sprintf(p, "null");
+        } else if (col_types[i] == COL_BOOL) {
+            p += sprintf(p, "%s", parse_bool(row->csv_data[i * 2 + 1]) ? "true" : "false");
+        } else {
+            /* numbers were validated against the JSON grammar, keep their source text */
+            p += sprintf(p, "%s", row->csv_data[i * 2 + 1]);
+            /* keep integral cells of a float column recognisable as floats */
+            if (col_types[i] == COL_FLOAT && strpbrk(row->csv_data[i * 2 + 1], ".eE") == NULL) {
+                p += sprintf(p, ".0");
+            }
+        }
         if (i < num_columns - 1) {
-            sprintf(json + strlen(json), ",");
+            p += sprintf(p, ",");
         }
-        sprintf(json + strlen(json), "\n");
+        p += sprintf(p, "\n");
     }
-    sprintf(json + strlen(json), "\t}");
+    sprintf(p, "\t}");
     return json;
 }
 
-int main(int argc, char *argv[]) {
-    FILE *csv_file = fopen(argv[1], "r");
-    FILE *json_file = fopen(argv[2], "w");
-    /*CSV rows*/
+static void put_u64(FILE *out, unsigned long v) {
+    unsigned char bytes[8];
     int i = 0;
-    int j = 0;
+    for (i = 0; i < 8; i++) {
+        bytes[i] = (unsigned char) (v & 0xFF);
+        v >>= 8;
+    }
+    fwrite(bytes, 1, 8, out);
+}
 
-    /* Used for check \n to determin number of lines*/
-    char c;
-    int row_index = 0;
-    int col_index = 0;
-    char **col_names = (char **) malloc(MAX_SIZE * sizeof(char *));
-    char *line = (char *) malloc(MAX_SIZE * sizeof(char));
-    CsvRow **rows;
-    /* Check if file name was passed as argument*/
-    if (argc != 3) {
-        printf("Input Format: csv_to_json.exe input_file.csv output_file.json\n");
-        return 0;
+static void put_i64(FILE *out, long v) {
+    unsigned char bytes[8];
+    unsigned long u = (unsigned long) v;
+    int i = 0;
+    for (i = 0; i < 8; i++) {
+        /* sign extend when long is narrower than 64 bits */
+        if (i < (int) sizeof(long)) {
+            bytes[i] = (unsigned char) (u & 0xFF);
+            u >>= 8;
+        } else {
+            bytes[i] = v < 0 ? 0xFF : 0x00;
+        }
     }
+    fwrite(bytes, 1, 8, out);
+}
 
-    /* Open CSV file*/
-    if (csv_file == NULL) {
-        printf("Wrong input file name\n");
-        return 0;
+static void put_f64(FILE *out, double v) {
+    unsigned char bytes[sizeof(double)];
+    unsigned char tmp;
+    unsigned int probe = 1;
+    int i = 0;
+    memcpy(bytes, &v, sizeof(double));
+    /* big endian host, store little endian */
+    if (*(unsigned char *) &probe == 0) {
+        for (i = 0; i < (int) sizeof(double) / 2; i++) {
+            tmp = bytes[i];
+            bytes[i] = bytes[sizeof(double) - 1 - i];
+            bytes[sizeof(double) - 1 - i] = tmp;
+        }
     }
+    fwrite(bytes, 1, sizeof(double), out);
+}
 
-    /* Count number of lines and columns*/
-    while (!feof(csv_file)) {
-        c = fgetc(csv_file);
-        if (c == '\n') {
-            num_lines++;
-            if (num_lines == 1) {
-                char *line = (char *) malloc(MAX_SIZE * sizeof(char));
-                char *result_line;
-                fgets(line, MAX_SIZE, csv_file);
-                result_line = strtok(line, ",");
-                while (result_line != NULL) {
-                    num_columns++;
-                    result_line = strtok(NULL, ",");
-                }
-                free(line);
+static unsigned long pad8(unsigned long n) {
+    return (n + 7) & ~7UL;
+}
+
+static void put_padding(FILE *out, unsigned long n) {
+    while (n % 8 != 0) {
+        fputc(0, out);
+        n++;
+    }
+}
+
+/* Size in bytes of a column's data section (without padding) */
+static unsigned long column_length(CsvRow **rows, int col) {
+    unsigned long length = 0;
+    int i = 0;
+    switch (col_types[col]) {
+        case COL_BOOL:
+            return (unsigned long) num_lines;
+        case COL_INT:
+        case COL_FLOAT:
+            return (unsigned long) num_lines * 8;
+        default:
+            length = ((unsigned long) num_lines + 1) * 8;
+            for (i = 0; i < num_lines; i++) {
+                length += strlen(rows[i]->csv_data[col * 2 + 1]);
             }
-        }
+            return length;
     }
-    rewind(csv_file);
-    rows = (CsvRow **) malloc(num_lines * sizeof(CsvRow * ));
-    /* Create CSV rows*/
-    for (i = 0; i < num_lines; i++) {
-        rows[i] = (CsvRow *) malloc(sizeof(CsvRow));
-        rows[i]->csv_data = (char **) malloc(num_columns * 2 * sizeof(char *));
-        for (j = 0; j < num_columns; j++) {
-            rows[i]->csv_data[j * 2] = (char *) malloc(MAX_SIZE * sizeof(char));
-            rows[i]->csv_data[j * 2 + 1] = (char *) malloc(MAX_SIZE * sizeof(char));
-        }
+}
+
+int write_columnar(FILE *out, char **col_names, CsvRow **rows) {
+    unsigned long offset = 24;
+    unsigned long validity_length = ((unsigned long) num_lines + 7) / 8;
+    unsigned long string_offset = 0;
+    int i = 0;
+    int j = 0;
+
+    /* header */
+    fwrite(COLUMNAR_MAGIC, 1, sizeof(COLUMNAR_MAGIC), out);
+    put_u64(out, (unsigned long) num_columns);
+    put_u64(out, (unsigned long) num_lines);
+
+    /* schema, data starts right after it */
+    for (j = 0; j < num_columns; j++) {
+        offset += 40 + pad8(strlen(col_names[j]));
     }
+    for (j = 0; j < num_columns; j++) {
+        unsigned long name_length = strlen(col_names[j]);
+        unsigned long length = column_length(rows, j);
+        put_u64(out, (unsigned long) col_types[j]);
+        put_u64(out, offset);
+        put_u64(out, offset + pad8(validity_length));
+        put_u64(out, length);
+        put_u64(out, name_length);
+        fwrite(col_names[j], 1, name_length, out);
+        put_padding(out, name_length);
+        offset += pad8(validity_length) + pad8(length);
+    }
+
+    /* validity bitmap, then data */
+    for (j = 0; j < num_columns; j++) {
+        for (i = 0; i < num_lines; i += 8) {
+            int bits = 0;
+            int k = 0;
+            for (k = 0; k < 8 && i + k < num_lines; k++) {
+                if (!is_null_cell(rows[i + k]->csv_data[j * 2 + 1], col_types[j])) {
+                    bits |= 1 << k;
+                }
+            }
+            fputc(bits, out);
+        }
+        put_padding(out, validity_length);
 
-    /* Store data in Rows */
-    while (fgets(line, MAX_SIZE, csv_file) != NULL) {
-        /* if the first line, record the names of columns*/
-        if (row_index == 0) {
-            char *result_line;
-            col_index = 0;
-            while (col_index < num_columns) {
-                if (col_index == 0) {
-                    result_line = strtok(line, ",");
+        for (i = 0; i < num_lines; i++) {
+            char *cell = rows[i]->csv_data[j * 2 + 1];
+            if (is_null_cell(cell, col_types[j])) {
+                /* zero placeholder, the bitmap marks it missing */
+                if (col_types[j] == COL_BOOL) {
+                    fputc(0, out);
                 } else {
-                    result_line = strtok(NULL, ",");
+                    put_u64(out, 0);
                 }
-                /* Get rid of \n, use LF instead of CRLF*/
-                strip(result_line);
-                /*if(col_index==num_columns-1){
-                    result_line[strlen(result_line) - 1] ='\0';
-                    printf("%s\n",result_line);
-                }*/
-                col_names[col_index] = malloc(MAX_SIZE * sizeof(char));
-                strcpy(col_names[col_index], result_line);
-                col_index++;
+            } else if (col_types[j] == COL_BOOL) {
+                fputc(parse_bool(cell), out);
+            } else if (col_types[j] == COL_INT) {
+                put_i64(out, strtol(cell, NULL, 10));
+            } else if (col_types[j] == COL_FLOAT) {
+                put_f64(out, strtod(cell, NULL));
+            }
+        }
+        if (col_types[j] == COL_STRING) {
+            string_offset = 0;
+            put_u64(out, 0);
+            for (i = 0; i < num_lines; i++) {
+                string_offset += strlen(rows[i]->csv_data[j * 2 + 1]);
+                put_u64(out, string_offset);
             }
+            for (i = 0; i < num_lines; i++) {
+                fwrite(rows[i]->csv_data[j * 2 + 1], 1, strlen(rows[i]->csv_data[j * 2 + 1]), out);
+            }
+        }
+        put_padding(out, column_length(rows, j));
+    }
+    return ferror(out) ? -1 : 0;
+}
+
+/*
+ * CSV tokenizer (RFC 4180): a state machine driven by the table below.
+ * On top of the RFC it accepts LF only line ends and keeps stray quotes
+ * inside unquoted fields. A CR outside quotes is dropped, so CRLF ends a record like LF does.
+ */
+typedef enum {
+    ST_FIELD_START,
+    ST_UNQUOTED,
+    ST_QUOTED,
+    ST_QUOTE_IN_QUOTED,
+    NUM_STATES
+} CsvState;
+
+typedef enum {
+    CH_OTHER,
+    CH_DELIMITER,
+    CH_QUOTE,
+    CH_CR,
+    CH_LF,
+    NUM_CLASSES
+} CsvCharClass;
+
+typedef enum {
+    ACT_NONE,
+    ACT_APPEND,
+    ACT_END_FIELD,
+    ACT_END_RECORD
+} CsvAction;
+
+typedef struct {
+    unsigned char next;
+    unsigned char action;
+} CsvTransition;
+
+static const CsvTransition csv_table[NUM_STATES][NUM_CLASSES] = {
+    /*                    other                       delimiter                       quote                          CR                               LF */
+    /* FIELD_START */    {{ST_UNQUOTED, ACT_APPEND},  {ST_FIELD_START, ACT_END_FIELD}, {ST_QUOTED, ACT_NONE},         {ST_FIELD_START, ACT_NONE},      {ST_FIELD_START, ACT_END_RECORD}},
+    /* UNQUOTED */       {{ST_UNQUOTED, ACT_APPEND},  {ST_FIELD_START, ACT_END_FIELD}, {ST_UNQUOTED, ACT_APPEND},      {ST_UNQUOTED, ACT_NONE},         {ST_FIELD_START, ACT_END_RECORD}},
+    /* QUOTED */         {{ST_QUOTED, ACT_APPEND},    {ST_QUOTED, ACT_APPEND},         {ST_QUOTE_IN_QUOTED, ACT_NONE}, {ST_QUOTED, ACT_APPEND},         {ST_QUOTED, ACT_APPEND}},
+    /* "" or closing */  {{ST_UNQUOTED, ACT_APPEND},  {ST_FIELD_START, ACT_END_FIELD}, {ST_QUOTED, ACT_APPEND},        {ST_QUOTE_IN_QUOTED, ACT_NONE},  {ST_FIELD_START, ACT_END_RECORD}}
+};
+
+/* Field being built and the fields of the current record */
+typedef struct {
+    char *field;
+    size_t field_length;
+    size_t field_capacity;
+    char **record;
+    int record_length;
+    int record_capacity;
+    /* for diagnostics: current line, line the record started on, records seen so far (header included) */
+    long line;
+    long record_line;
+    long records;
+    /* the record had a quote, so a single empty field is a value ("") and not a blank line */
+    int record_quoted;
+} CsvBuilder;
+
+static void append_field(CsvBuilder *builder, const char *s, size_t length) {
+    if (builder->field_length + length + 1 > builder->field_capacity) {
+        while (builder->field_length + length + 1 > builder->field_capacity) {
+            builder->field_capacity *= 2;
+        }
+        builder->field = (char *) realloc(builder->field, builder->field_capacity);
+    }
+    memcpy(builder->field + builder->field_length, s, length);
+    builder->field_length += length;
+}
+
+static void end_field(CsvBuilder *builder) {
+    char *value = (char *) malloc(builder->field_length + 1);
+    memcpy(value, builder->field, builder->field_length);
+    value[builder->field_length] = '\0';
+    if (builder->record_length == builder->record_capacity) {
+        builder->record_capacity *= 2;
+        builder->record = (char **) realloc(builder->record, builder->record_capacity * sizeof(char *));
+    }
+    builder->record[builder->record_length++] = value;
+    builder->field_length = 0;
+}
+
+/* Hand the finished record over: the first one names the columns, the others become rows */
+static CsvRow **end_record(CsvBuilder *builder, char ***col_names, CsvRow **rows, int *capacity) {
+    int j = 0;
+    CsvRow *row;
+    end_field(builder);
+    /* blank line */
+    if (builder->record_length == 1 && builder->record[0][0] == '\0' && !builder->record_quoted) {
+        free(builder->record[0]);
+        builder->record_length = 0;
+        return rows;
+    }
+    builder->records++;
+    if (*col_names == NULL) {
+        num_columns = builder->record_length;
+        *col_names = builder->record;
+        builder->record_capacity = num_columns > 16 ? num_columns : 16;
+        builder->record = (char **) malloc(builder->record_capacity * sizeof(char *));
+        builder->record_length = 0;
+        return rows;
+    }
+    if (builder->record_length != num_columns) {
+        fprintf(stderr, "Warning: line %ld (record %ld) has %d fields but the header has %d, %s\n",
+                builder->record_line, builder->records, builder->record_length, num_columns,
+                builder->record_length < num_columns ? "missing fields are left empty" : "extra fields are dropped");
+    }
+    if (num_lines == *capacity) {
+        *capacity *= 2;
+        rows = (CsvRow **) realloc(rows, *capacity * sizeof(CsvRow *));
+    }
+    row = (CsvRow *) malloc(sizeof(CsvRow));
+    row->csv_data = (char **) malloc(num_columns * 2 * sizeof(char *));
+    for (j = 0; j < num_columns; j++) {
+        /* names are shared with col_names, short records are padded with empty cells */
+        row->csv_data[j * 2] = (*col_names)[j];
+        if (j < builder->record_length) {
+            row->csv_data[j * 2 + 1] = builder->record[j];
         } else {
-            char *result_line;
-            col_index = 0;
-            while (col_index < num_columns) {
-                if (col_index == 0) {
-                    result_line = strtok(line, ",");
-                } else {
-                    result_line = strtok(NULL, ",");
+            row->csv_data[j * 2 + 1] = (char *) calloc(1, 1);
+        }
+    }
+    /* cells past the header are dropped */
+    for (; j < builder->record_length; j++) {
+        free(builder->record[j]);
+    }
+    builder->record_length = 0;
+    rows[num_lines++] = row;
+    return rows;
+}
+
+/*
+ * Read the whole CSV file in one pass (it may be a pipe), the header goes into col_names and every other record becomes a row.
+ * Records with a different number of fields than the header are reported on stderr.
+ * Returns NULL (after reporting it) when the file ends inside a quoted field.
+ */
+CsvRow **read_csv(FILE *csv_file, char ***col_names, char delimiter) {
+    unsigned char char_class[256];
+    char *buffer = (char *) malloc(CSV_BUFFER_SIZE);
+    size_t length;
+    int state = ST_FIELD_START;
+    int capacity = 16;
+    CsvRow **rows = (CsvRow **) malloc(capacity * sizeof(CsvRow *));
+    CsvBuilder builder;
+
+    builder.field_capacity = 64;
+    builder.field = (char *) malloc(builder.field_capacity);
+    builder.field_length = 0;
+    builder.record_capacity = 16;
+    builder.record = (char **) malloc(builder.record_capacity * sizeof(char *));
+    builder.record_length = 0;
+    builder.line = 1;
+    builder.record_line = 1;
+    builder.records = 0;
+    builder.record_quoted = 0;
+    *col_names = NULL;
+
+    memset(char_class, CH_OTHER, sizeof(char_class));
+    char_class[(unsigned char) delimiter] = CH_DELIMITER;
+    char_class['"'] = CH_QUOTE;
+    char_class['\r'] = CH_CR;
+    char_class['\n'] = CH_LF;
+
+    while ((length = fread(buffer, 1, CSV_BUFFER_SIZE, csv_file)) > 0) {
+        const char *p = buffer;
+        const char *end = buffer + length;
+        while (p < end) {
+            const char *run = p;
+            CsvTransition transition;
+            /* fast path: copy plain bytes of an unquoted field, or anything up to the next quote in a quoted one */
+            if (state == ST_FIELD_START || state == ST_UNQUOTED) {
+                while (run < end && char_class[(unsigned char) *run] == CH_OTHER) {
+                    run++;
                 }
-                /* Get rid of \n use LF instead of CRLF*/
-                strip(result_line);
-                /*if(col_index==num_columns-1){
-                    result_line[strlen(result_line) - 1] = '\0';
-                    printf("%s\n",result_line);
-                }*/
-                strcpy(rows[row_index - 1]->csv_data[col_index * 2], col_names[col_index]);
-                strcpy(rows[row_index - 1]->csv_data[col_index * 2 + 1], result_line);
-                col_index++;
+                if (run != p) {
+                    append_field(&builder, p, run - p);
+                    state = ST_UNQUOTED;
+                    p = run;
+                    continue;
+                }
+            } else if (state == ST_QUOTED) {
+                run = (const char *) memchr(p, '"', end - p);
+                if (run == NULL) {
+                    run = end;
+                }
+                if (run != p) {
+                    const char *newline = p;
+                    while ((newline = (const char *) memchr(newline, '\n', run - newline)) != NULL) {
+                        builder.line++;
+                        newline++;
+                    }
+                    append_field(&builder, p, run - p);
+                    p = run;
+                    continue;
+                }
+            }
+
+            transition = csv_table[state][char_class[(unsigned char) *p]];
+            if (char_class[(unsigned char) *p] == CH_QUOTE) {
+                builder.record_quoted = 1;
             }
+            if (transition.action == ACT_APPEND) {
+                append_field(&builder, p, 1);
+            } else if (transition.action == ACT_END_FIELD) {
+                end_field(&builder);
+            } else if (transition.action == ACT_END_RECORD) {
+                rows = end_record(&builder, col_names, rows, &capacity);
+            }
+            if (*p == '\n') {
+                builder.line++;
+            }
+            if (transition.action == ACT_END_RECORD) {
+                builder.record_line = builder.line;
+                builder.record_quoted = 0;
+            }
+            state = transition.next;
+            p++;
         }
-        row_index++;
     }
-    fclose(csv_file);
 
-    /*Write into Json File*/
-    fprintf(json_file, "[\n");
-    /*Total nbum_lines -1*/
-    for (i = 0; i < num_lines; i++) {
-        fprintf(json_file, "%s", csv_row_to_json(rows[i]));
-        if (i < num_lines - 1) {
-            fprintf(json_file, ",\n");
+    if (state == ST_QUOTED) {
+        fprintf(stderr, "Error: line %ld (record %ld): quoted field is not closed before the end of the file\n",
+                builder.record_line, builder.records + 1);
+        end_field(&builder);
+        while (builder.record_length > 0) {
+            free(builder.record[--builder.record_length]);
         }
+        free(builder.field);
+        free(builder.record);
+        free(buffer);
+        free_csv(*col_names, rows);
+        *col_names = NULL;
+        num_columns = 0;
+        num_lines = 0;
+        return NULL;
     }
-    fprintf(json_file, "\n]");
-    fclose(json_file);
 
-    /*Free memory*/
-    free(col_names);
-    free(line);
+    /* last record without a line end */
+    if (state != ST_FIELD_START || builder.field_length > 0 || builder.record_length > 0) {
+        rows = end_record(&builder, col_names, rows, &capacity);
+    }
+    if (*col_names == NULL) {
+        *col_names = (char **) malloc(sizeof(char *));
+    }
+    free(builder.field);
+    free(builder.record);
+    free(buffer);
+    return rows;
+}
+
+void free_csv(char **col_names, CsvRow **rows) {
+    int i = 0;
+    int j = 0;
     for (i = 0; i < num_lines; i++) {
         for (j = 0; j < num_columns; j++) {
-            free(rows[i]->csv_data[j * 2]);
             free(rows[i]->csv_data[j * 2 + 1]);
         }
         free(rows[i]->csv_data);
         free(rows[i]);
     }
     free(rows);
-    return 0;
-}
\ No newline at end of file
+    for (i = 0; i < num_columns; i++) {
+        free(col_names[i]);
+    }
+    free(col_names);
+    free(col_types);
+    col_types = NULL;
+}
+
+#ifndef PIPELINE
+int main(int argc, char *argv[]) {
+    FILE *csv_file;
+    FILE *out_file;
+    /* -b switches the output to the columnar binary layout */
+    int binary = 0;
+    /* -d sets the field delimiter, \t for tab */
+    char delimiter = ',';
+    int arg = 1;
+    int status = 0;
+    /*CSV rows*/
+    int i = 0;
+    char **col_names;
+    char *json;
+    CsvRow **rows;
+    /* Check if file name was passed as argument*/
+    while (arg < argc - 2) {
+        if (strcmp(argv[arg], "-b") == 0) {
+            binary = 1;
+            arg++;
+        } else if (strcmp(argv[arg], "-d") == 0 && arg + 1 < argc - 2 && argv[arg + 1][0] != '\0') {
+            delimiter = strcmp(argv[arg + 1], "\\t") == 0 ? '\t' : argv[arg + 1][0];
+            arg += 2;
+        } else {
+            break;
+        }
+    }
+    if (argc - arg != 2 || delimiter == '"' || delimiter == '\r' || delimiter == '\n') {
+        printf("Input Format: csv_to_json.exe [-b] [-d delimiter] input_file.csv output_file.json\n");
+        return 0;
+    }
+
+    /* Open CSV file*/
+    csv_file = open_input(argv[arg]);
+    if (csv_file == NULL) {
+        printf("Wrong input file name\n");
+        return 0;
+    }
+
+    rows = read_csv(csv_file, &col_names, delimiter);
+    if (close_stream(csv_file) != 0) {
+        /* the rows are incomplete, do not write anything */
+        printf("Failed to decompress %s\n", argv[arg]);
+        free_csv(col_names, rows);
+        return 1;
+    }
+    if (rows == NULL) {
+        /* malformed CSV, already reported by read_csv */
+        return 1;
+    }
+
+    infer_column_types(rows);
+    out_file = open_output(argv[arg + 1], binary ? "wb" : "w");
+    if (out_file == NULL) {
+        printf("Wrong output file name\n");
+        free_csv(col_names, rows);
+        return 1;
+    }
+
+    if (binary) {
+        /*Write into columnar binary File*/
+        if (write_columnar(out_file, col_names, rows) != 0) {
+            printf("Failed to write %s\n", argv[arg + 1]);
+            status = 1;
+        }
+    } else {
+        /*Write into Json File*/
+        fprintf(out_file, "[\n");
+        /*Total nbum_lines -1*/
+        for (i = 0; i < num_lines; i++) {
+            json = csv_row_to_json(rows[i]);
+            fputs(json, out_file);
+            free(json);
+            if (i < num_lines - 1) {
+                fprintf(out_file, ",\n");
+            }
+        }
+        fprintf(out_file, "\n]");
+    }
+    if (close_stream(out_file) != 0) {
+        /* a truncated .gz / .zst must not look like a success to scripts */
+        printf("Failed to write %s\n", argv[arg + 1]);
+        status = 1;
+    }
+
+    /*Free memory*/
+    free_csv(col_names, rows);
+    return status;
+}
+#endif
@@ -3,11 +3,58 @@
 #ifndef CSV_TO_JSON_H
 #define CSV_TO_JSON_H
 
-#define MAX_SIZE 4096
+#include <stdio.h>
+
+/* bytes read from the CSV file at a time */
+#define CSV_BUFFER_SIZE 65536
+
+/* Inferred type of a column, ordered from most to least specific */
+typedef enum {
+    COL_BOOL,
+    COL_INT,
+    COL_FLOAT,
+    COL_STRING
+} ColType;
+
+/* csv_data holds (column name, cell) pairs, the names point into col_names */
 typedef struct {
     char **csv_data;
 }CsvRow ;
 
+/*
+ * Columnar binary layout (all integers are 64-bit little endian,
+ * every section starts on an 8 byte boundary so the file can be mmap-ed):
+ *
+ *   header : "CSVCOL2\0" | num_columns | num_rows
+ *   schema : per column  type | validity_offset | data_offset | data_length | name_length | name (zero padded)
+ *   per column:
+ *     validity at validity_offset: (num_rows + 7) / 8 bytes, bit i % 8 of byte i / 8 is set
+ *              when row i has a value (empty cells of typed columns are missing, stored as 0)
+ *     data at data_offset:
+ *            COL_BOOL   num_rows x u8 (0 / 1)
+ *            COL_INT    num_rows x i64
+ *            COL_FLOAT  num_rows x f64 (IEEE-754)
+ *            COL_STRING (num_rows + 1) x u64 offsets, then the concatenated bytes
+ */
+#define COLUMNAR_MAGIC "CSVCOL2"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int num_columns;
+extern int num_lines;
+extern ColType *col_types;
+
 void strip(char *s);
+ColType classify_cell(const char *s);
+void infer_column_types(CsvRow **rows);
 char* csv_row_to_json(CsvRow *row);
-#endif
\ No newline at end of file
+int write_columnar(FILE *out, char **col_names, CsvRow **rows);
+CsvRow **read_csv(FILE *csv_file, char ***col_names, char delimiter);
+void free_csv(char **col_names, CsvRow **rows);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
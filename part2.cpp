@@ -4,10 +4,64 @@
 #include <vector>
 #include <cmath>
 #include <algorithm>
+#include <charconv>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <sstream>
 #include "part2.h"
+#include "compress_io.h"
 
 using namespace std;
 
+size_t JSONObject::lookup(const string &key) const {
+    if (!index.empty()) {
+        auto it = index.find(key);
+        return it == index.end() ? members.size() : it->second;
+    }
+    for (size_t i = 0; i < members.size(); ++i) {
+        if (members[i].first.size() == key.size() && members[i].first == key) {
+            return i;
+        }
+    }
+    return members.size();
+}
+
+JSONValue &JSONObject::operator[](const string &key) {
+    size_t i = lookup(key);
+    if (i == members.size()) {
+        emplace(key, JSONValue());
+    }
+    return members[i].second;
+}
+
+const JSONValue &JSONObject::operator[](const string &key) const {
+    static const JSONValue nullValue;
+    const JSONValue *value = find(key);
+    return value == nullptr ? nullValue : *value;
+}
+
+const JSONValue *JSONObject::find(const string &key) const {
+    size_t i = lookup(key);
+    return i == members.size() ? nullptr : &members[i].second;
+}
+
+/* Same as unordered_map::emplace, an existing key is left untouched */
+bool JSONObject::emplace(string key, JSONValue value) {
+    if (lookup(key) != members.size()) {
+        return false;
+    }
+    members.emplace_back(std::move(key), std::move(value));
+    if (!index.empty()) {
+        index.emplace(members.back().first, members.size() - 1);
+    } else if (members.size() > indexThreshold) {
+        for (size_t i = 0; i < members.size(); ++i) {
+            index.emplace(members[i].first, i);
+        }
+    }
+    return true;
+}
+
 JSONValue JSONParser::parse() {
     skipWhiteSpace();
 
@@ -98,7 +152,7 @@ string JSONParser::parseString() {
 
                     if (codePoint < 0xD800 || codePoint > 0xDFFF) {
                         result += static_cast<char>(codePoint);
-                        index += 5;
+                        index += 4;
                     } else {
                         throw invalid_argument("Invalid JSON string");
                     }
@@ -125,8 +179,10 @@ string JSONParser::parseString() {
     }
 }
 
-double JSONParser::parseNumber() {
+/* Parse straight from the buffer, locale independent, keeping integers exact */
+JSONValue JSONParser::parseNumber() {
     size_t startIndex = index;
+    bool isInteger = true;
 
     if (getCurrentChar() == '-') {
         ++index;
@@ -138,6 +194,7 @@ double JSONParser::parseNumber() {
 
     if (getCurrentChar() == '.') {
         ++index;
+        isInteger = false;
 
         while (index < jsonString.size() && isdigit(getCurrentChar())) {
             ++index;
@@ -146,6 +203,7 @@ double JSONParser::parseNumber() {
 
     if (getCurrentChar() == 'e' || getCurrentChar() == 'E') {
         ++index;
+        isInteger = false;
 
         if (getCurrentChar() == '-' || getCurrentChar() == '+') {
             ++index;
@@ -156,9 +214,25 @@ double JSONParser::parseNumber() {
         }
     }
 
-    string numberString = jsonString.substr(startIndex, index - startIndex);
+    const char *first = jsonString.data() + startIndex;
+    const char *last = jsonString.data() + index;
     skipWhiteSpace();
-    return stod(numberString);
+
+    if (isInteger) {
+        long long integerValue;
+        from_chars_result result = from_chars(first, last, integerValue);
+        if (result.ec == errc() && result.ptr == last) {
+            return {integerValue};
+        }
+        /* too large for long long, fall back to double */
+    }
+
+    double numberValue;
+    from_chars_result result = from_chars(first, last, numberValue);
+    if (result.ec != errc() || result.ptr != last) {
+        throw invalid_argument("Invalid JSON number");
+    }
+    return {numberValue};
 }
 
 vector <JSONValue> JSONParser::parseArray() {
@@ -182,17 +256,23 @@ vector <JSONValue> JSONParser::parseArray() {
     return result;
 }
 
-unordered_map <string, JSONValue> JSONParser::parseObject() {
-    unordered_map <string, JSONValue> result;
+JSONObject JSONParser::parseObject() {
+    JSONObject result;
 
     expect("{");
 
     while (getCurrentChar() != '}') {
         string key = parseString();
         expect(":");
-        JSONValue value = parse();
 
-        result.emplace(std::move(key), std::move(value));
+        if (keyFilter != nullptr && !keyFilter(key)) {
+            /* keep the key so it is still reported, but never build its value */
+            skipValue();
+            result.emplace(std::move(key), JSONValue());
+        } else {
+            JSONValue value = parse();
+            result.emplace(std::move(key), std::move(value));
+        }
 
         if (getCurrentChar() == ',') {
             ++index;
@@ -207,70 +287,258 @@ unordered_map <string, JSONValue> JSONParser::parseObject() {
     return result;
 }
 
-/* Generate the header file for a class */
-string generate_impl_file(JSONValue inJsonValue, ofstream &header_file, ofstream &cpp_file) {
-    string className = inJsonValue.objectValue["Class"].stringValue;
-    /* write to header file */
-    header_file << "class " << className << " {\n";
-    header_file << "private:\n";
-    /* write to cpp file */
-    cpp_file << className << "::" << className << "(";
+/* Move past a string (including its quotes) without decoding it */
+void JSONParser::skipString() {
+    ++index;
+    while (true) {
+        index = jsonString.find_first_of("\"\\", index);
+        if (index == string::npos) {
+            throw invalid_argument("Invalid JSON string");
+        }
+        if (jsonString[index] == '\"') {
+            ++index;
+            return;
+        }
+        index += 2;
+    }
+}
 
-    string headerParamStr;
-    string consParamStr;
-    string consInitStr;
-    string objInstStr;
-    unordered_map <string, JSONValue> jsonMap = inJsonValue.objectValue;
+/* Move past any value by bracket matching, nothing is materialized */
+void JSONParser::skipValue() {
+    char firstChar = getCurrentChar();
+
+    if (firstChar == '\"') {
+        skipString();
+    } else if (firstChar == '[' || firstChar == '{') {
+        int depth = 0;
+        while (index < jsonString.size()) {
+            char currentChar = jsonString[index];
+            if (currentChar == '\"') {
+                skipString();
+                continue;
+            }
+            if (currentChar == '[' || currentChar == '{') {
+                ++depth;
+            } else if (currentChar == ']' || currentChar == '}') {
+                --depth;
+                if (depth == 0) {
+                    ++index;
+                    break;
+                }
+            }
+            ++index;
+        }
+        if (depth != 0) {
+            throw invalid_argument("Invalid JSON string");
+        }
+    } else {
+        /* null, true, false or a number */
+        while (index < jsonString.size() && jsonString[index] != ',' && jsonString[index] != '}' &&
+               jsonString[index] != ']' && !isspace(jsonString[index])) {
+            ++index;
+        }
+    }
+
+    skipWhiteSpace();
+}
+
+/* Members generate_impl_file reads, everything else can be skipped while parsing */
+bool is_generator_key(const string &key) {
+    return key.find("Class") != string::npos || key.find("Instance") != string::npos ||
+           key.find("Field") != string::npos || key.find("Value") != string::npos;
+}
+
+/* Quoted C++ string literal for s, escapes quotes, backslashes and control characters */
+string cpp_string_literal(const string &s) {
+    string literal = "\"";
+    for (char c: s) {
+        unsigned char u = (unsigned char) c;
+        if (c == '\"' || c == '\\') {
+            literal += '\\';
+            literal += c;
+        } else if (c == '\n') {
+            literal += "\\n";
+        } else if (c == '\r') {
+            literal += "\\r";
+        } else if (c == '\t') {
+            literal += "\\t";
+        } else if (u < 0x20 || u == 0x7F) {
+            /* always 3 octal digits, so a following digit is not taken into the escape */
+            char octal[5];
+            snprintf(octal, sizeof(octal), "\\%03o", u);
+            literal += octal;
+        } else {
+            literal += c;
+        }
+    }
+    return literal + "\"";
+}
+
+/* float is enough when its shortest form reads back as the same double */
+bool fits_float(double value) {
+    char buffer[64];
+    to_chars_result result = to_chars(buffer, buffer + sizeof(buffer), float(value));
+    double reparsed = 0;
+    from_chars(buffer, result.ptr, reparsed);
+    return reparsed == value;
+}
 
-    for (std::pair <std::string, JSONValue> element: jsonMap) {
+/* Shortest literal that round-trips exactly, as a float (with f suffix) or as a double */
+string shortest_float_literal(double value, bool asFloat) {
+    char buffer[64];
+    to_chars_result result = asFloat ? to_chars(buffer, buffer + sizeof(buffer), float(value))
+                                     : to_chars(buffer, buffer + sizeof(buffer), value);
+    string numStr(buffer, result.ptr);
+
+    if (numStr == "inf" || numStr == "-inf" || numStr == "nan" || numStr == "-nan") {
+        throw invalid_argument("Unsupported JSON number: " + numStr);
+    }
+    /* keep it a floating literal, e.g. 440 -> 440.0 */
+    if (numStr.find_first_of(".e") == string::npos) {
+        numStr += ".0";
+    }
+    return asFloat ? numStr + "f" : numStr;
+}
+
+/* Narrowest C++ type holding value */
+string field_type(const JSONValue &value) {
+    if (value.type == JSONValueType::String) {
+        return "string";
+    } else if (value.type == JSONValueType::Number) {
+        if (value.isInteger) {
+            return (value.integerValue < INT_MIN || value.integerValue > INT_MAX) ? "long long" : "int";
+        }
+        return fits_float(value.numberValue) ? "float" : "double";
+    } else if (value.type == JSONValueType::Boolean) {
+        /* not needed actually */
+        return "bool";
+    } else if (value.type == JSONValueType::Array || value.type == JSONValueType::Object) {
+        /* not needed either , so not implemented*/
+        throw invalid_argument("Unsupported JSON value type: Array");
+    }
+    throw invalid_argument(
+            R"(Unsupported JSON value type. Either "Value" is not supported, or "Value" of corresponding "Field" is missing)");
+}
+
+/* Constructor argument for value in a field of type typeName */
+string field_literal(const JSONValue &value, const string &typeName) {
+    if (typeName == "string") {
+        return cpp_string_literal(value.stringValue);
+    } else if (typeName == "bool") {
+        return to_string(value.booleanValue);
+    } else if (typeName == "float" || typeName == "double") {
+        return shortest_float_literal(value.numberValue, typeName == "float");
+    } else if (value.integerValue == LLONG_MIN) {
+        /* the literal 9223372036854775808LL itself would overflow */
+        return "(-9223372036854775807LL - 1)";
+    } else if (value.integerValue < INT_MIN || value.integerValue > INT_MAX) {
+        return to_string(value.integerValue) + "LL";
+    }
+    return to_string(value.integerValue);
+}
+
+/* Read Class, Instance and the FieldN / ValueN pairs of one JSON object */
+void collect_instance(const JSONValue &inJsonValue, GeneratedInstance &instance) {
+    const JSONObject &jsonMap = inJsonValue.objectValue;
+    instance.className = jsonMap["Class"].stringValue;
+    instance.instanceName = jsonMap["Instance"].stringValue;
+
+    for (const JSONObject::Member &element: jsonMap) {
         if (element.first.find("Field") != string::npos) {
             string index = element.first.substr(5);
             string valueKey = "Value" + index;
             /* check value type */
-            JSONValue value = jsonMap[valueKey];
-            consInitStr += ("this->" + element.second.stringValue + " = " + element.second.stringValue + ";\n");
-            if (value.type == JSONValueType::String) {
-                headerParamStr += ("string " + element.second.stringValue + ";\n");
-                consParamStr += ("string " + element.second.stringValue);
-                objInstStr += ("\"" + value.stringValue + "\"");
-            } else if (value.type == JSONValueType::Number) {
-                if (ceil(value.numberValue) == floor(value.numberValue)) {
-                    headerParamStr += ("int " + element.second.stringValue + ";\n");
-                    consParamStr += ("int " + element.second.stringValue);
-                    objInstStr += (to_string(int(value.numberValue)));
-                } else {
-                    headerParamStr += ("float " + element.second.stringValue + ";\n");
-                    consParamStr += ("float " + element.second.stringValue);
-                    string numStr = to_string((value.numberValue));
-                    /* it won't trim 440.0 to 440. though it's not required (as 440 is int and checked above) */
-                    numStr.erase(numStr.find_last_not_of('0') + 1, std::string::npos);
-                    numStr.erase(numStr.find_last_not_of('.') + 1, std::string::npos);
-                    objInstStr += (numStr + "f");
-                }
-            } else if (value.type == JSONValueType::Boolean) {
-                /* not needed actually */
-                headerParamStr += ("bool " + element.second.stringValue + ";\n");
-                consParamStr += ("bool " + element.second.stringValue);
-                objInstStr += (to_string(value.booleanValue));
-            } else if (value.type == JSONValueType::Array || value.type == JSONValueType::Object) {
-                /* not needed either , so not implemented*/
-                throw invalid_argument("Unsupported JSON value type: Array");
-            } else {
-                throw invalid_argument(
-                        R"(Unsupported JSON value type. Either "Value" is not supported, or "Value" of corresponding "Field" is missing)");
-            }
-            consParamStr += ", ";
-            objInstStr += ", ";
+            const JSONValue &value = jsonMap[valueKey];
+            field_type(value);
+            instance.fields.emplace_back(element.second.stringValue, value);
         } else if ((element.first.find("Value") == string::npos) && (element.first.find("Class") == string::npos) &&
                    (element.first.find("Instance") == string::npos)) {
             /* ignore unsupported non-Value/Class/Instance */
             cout << "Unsupported JSON entry: " << element.first << "! Ignore it...\n";
         }
     }
+}
+
+/*
+ * Field types of every class, checked over all of its instances: int widens to long long and
+ * float to double, any other difference in fields or types is an error.
+ * Fills in the constructor arguments of each instance once the types are known.
+ */
+vector <GeneratedClass> unify_classes(vector <GeneratedInstance> &instances) {
+    vector <GeneratedClass> classes;
+    for (const GeneratedInstance &instance: instances) {
+        auto generatedClass = find_if(classes.begin(), classes.end(),
+                                      [&instance](const GeneratedClass &c) { return c.name == instance.className; });
+        if (generatedClass == classes.end()) {
+            classes.emplace_back();
+            classes.back().name = instance.className;
+            for (const auto &field: instance.fields) {
+                classes.back().fields.emplace_back(field.first, field_type(field.second));
+            }
+            continue;
+        }
+
+        if (instance.fields.size() != generatedClass->fields.size()) {
+            throw invalid_argument("Instance " + instance.instanceName + " of class " + instance.className +
+                                   " has different fields than the first instance");
+        }
+        for (auto &classField: generatedClass->fields) {
+            auto field = find_if(instance.fields.begin(), instance.fields.end(),
+                                 [&classField](const pair <string, JSONValue> &f) { return f.first == classField.first; });
+            if (field == instance.fields.end()) {
+                throw invalid_argument("Instance " + instance.instanceName + " of class " + instance.className +
+                                       " has no field " + classField.first);
+            }
+            string typeName = field_type(field->second);
+            if (typeName == classField.second) {
+                continue;
+            }
+            if ((typeName == "int" || typeName == "long long") &&
+                (classField.second == "int" || classField.second == "long long")) {
+                classField.second = "long long";
+            } else if ((typeName == "float" || typeName == "double") &&
+                       (classField.second == "float" || classField.second == "double")) {
+                classField.second = "double";
+            } else {
+                throw invalid_argument("Field " + classField.first + " of class " + instance.className + " is " +
+                                       classField.second + " in one instance and " + typeName + " in " +
+                                       instance.instanceName);
+            }
+        }
+    }
+
+    /* arguments follow the field order of the class */
+    for (GeneratedInstance &instance: instances) {
+        const GeneratedClass &generatedClass = *find_if(classes.begin(), classes.end(),
+                                                        [&instance](const GeneratedClass &c) {
+                                                            return c.name == instance.className;
+                                                        });
+        instance.arguments.clear();
+        for (const auto &classField: generatedClass.fields) {
+            auto field = find_if(instance.fields.begin(), instance.fields.end(),
+                                 [&classField](const pair <string, JSONValue> &f) { return f.first == classField.first; });
+            instance.arguments += (instance.arguments.empty() ? "" : ", ") + field_literal(field->second, classField.second);
+        }
+    }
+    return classes;
+}
+
+/* Generate the header file for a class */
+void generate_impl_file(const GeneratedClass &generatedClass, ostream &header_file, ostream &cpp_file) {
+    const string &className = generatedClass.name;
+    string headerParamStr;
+    string consParamStr;
+    string consInitStr;
 
-    consParamStr.erase(consParamStr.length() - 2); // removes last 3 characters
-    objInstStr.erase(objInstStr.length() - 2); // which is ", "
+    for (const auto &field: generatedClass.fields) {
+        headerParamStr += (field.second + " " + field.first + ";\n");
+        consParamStr += (consParamStr.empty() ? "" : ", ") + field.second + " " + field.first;
+        consInitStr += ("this->" + field.first + " = " + field.first + ";\n");
+    }
 
+    /* write to header file */
+    header_file << "class " << className << " {\n";
+    header_file << "private:\n";
     header_file << headerParamStr;
 
     header_file << "public:\n";
@@ -282,17 +550,219 @@ string generate_impl_file(JSONValue inJsonValue, ofstream &header_file, ofstream
     header_file << "protected: \n";
     header_file << "};\n";
 
+    /* write to cpp file */
+    cpp_file << className << "::" << className << "(";
     cpp_file << consParamStr << ") {\n";
     cpp_file << consInitStr << "}\n";
+}
+
+/* Seeded FNV-1a with a murmur3 finalizer, the generated lookup uses the same function */
+uint32_t registry_hash(const string &key, uint32_t seed) {
+    uint32_t hash = 2166136261u ^ seed;
+    for (char c: key) {
+        hash ^= (unsigned char) c;
+        hash *= 16777619u;
+    }
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35u;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+/* Slot of key in a table built by build_perfect_hash */
+static uint32_t perfect_hash_slot(const string &key, const vector<int> &displacements) {
+    uint32_t size = uint32_t(displacements.size());
+    int displacement = displacements[registry_hash(key, 0) % size];
+    return displacement < 0 ? uint32_t(-displacement - 1) : registry_hash(key, uint32_t(displacement)) % size;
+}
+
+/*
+ * Minimal perfect hash by hash and displace: keys are put into n buckets by registry_hash(key, 0),
+ * then, largest bucket first, each bucket gets the first seed that sends all of its keys to free slots
+ * of an n slot table. Buckets with a single key take a free slot directly, stored as -(slot + 1).
+ * slotKeys maps every slot to the index of its key.
+ */
+void build_perfect_hash(const vector <string> &keys, vector<int> &displacements, vector<int> &slotKeys) {
+    uint32_t size = uint32_t(keys.size());
+    vector <vector<int>> buckets(size);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        buckets[registry_hash(keys[i], 0) % size].push_back(int(i));
+    }
+    vector<uint32_t> order(size);
+    for (uint32_t b = 0; b < size; ++b) {
+        order[b] = b;
+    }
+    stable_sort(order.begin(), order.end(),
+                [&buckets](uint32_t a, uint32_t b) { return buckets[a].size() > buckets[b].size(); });
+
+    displacements.assign(size, 0);
+    slotKeys.assign(size, -1);
+    vector<uint32_t> slots;
+    size_t next = 0;
+    for (; next < order.size() && buckets[order[next]].size() > 1; ++next) {
+        const vector<int> &bucket = buckets[order[next]];
+        bool placed = false;
+        for (uint32_t seed = 1; seed < (1u << 20) && !placed; ++seed) {
+            slots.clear();
+            placed = true;
+            for (int key: bucket) {
+                uint32_t slot = registry_hash(keys[key], seed) % size;
+                if (slotKeys[slot] != -1 || find(slots.begin(), slots.end(), slot) != slots.end()) {
+                    placed = false;
+                    break;
+                }
+                slots.push_back(slot);
+            }
+            if (placed) {
+                displacements[order[next]] = int(seed);
+                for (size_t k = 0; k < bucket.size(); ++k) {
+                    slotKeys[slots[k]] = bucket[k];
+                }
+            }
+        }
+        if (!placed) {
+            throw runtime_error("No perfect hash found for key \"" + keys[bucket[0]] + "\"");
+        }
+    }
+    uint32_t freeSlot = 0;
+    for (; next < order.size() && buckets[order[next]].size() == 1; ++next) {
+        while (slotKeys[freeSlot] != -1) {
+            ++freeSlot;
+        }
+        displacements[order[next]] = -int(freeSlot) - 1;
+        slotKeys[freeSlot] = buckets[order[next]][0];
+    }
+
+    /* every key has to come back to its own slot */
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (slotKeys[perfect_hash_slot(keys[i], displacements)] != int(i)) {
+            throw logic_error("Perfect hash does not map \"" + keys[i] + "\" to its slot");
+        }
+    }
+}
 
+/* Emit one lookup function over keys, keys[i] belongs to instances()[i] and is the keyName of it */
+static void generate_lookup(const string &className, const string &functionName, const string &keyName,
+                            const vector <string> &keys, ostream &header_file, ostream &cpp_file) {
+    /* duplicates would never get a perfect hash, report them as what they are */
+    vector <string> sortedKeys = keys;
+    sort(sortedKeys.begin(), sortedKeys.end());
+    auto duplicate = adjacent_find(sortedKeys.begin(), sortedKeys.end());
+    if (duplicate != sortedKeys.end()) {
+        throw invalid_argument("Duplicate " + keyName + " \"" + *duplicate + "\" in " + className +
+                               ", cannot generate " + functionName);
+    }
+
+    vector<int> displacements;
+    vector<int> slotKeys;
+    build_perfect_hash(keys, displacements, slotKeys);
+
+    header_file << "const " << className << " *" << functionName << "(const char *key);\n";
+
+    cpp_file << "const " << className << " *" << functionName << "(const char *key) {\n";
+    cpp_file << "static const int displacements[] = {";
+    for (size_t i = 0; i < displacements.size(); ++i) {
+        cpp_file << (i == 0 ? "" : ", ") << displacements[i];
+    }
+    cpp_file << "};\n";
+    /* keys and instance indices in slot order */
+    cpp_file << "static const char *const keys[] = {";
+    for (size_t i = 0; i < slotKeys.size(); ++i) {
+        cpp_file << (i == 0 ? "" : ", ") << cpp_string_literal(keys[slotKeys[i]]);
+    }
+    cpp_file << "};\n";
+    cpp_file << "static const int indices[] = {";
+    for (size_t i = 0; i < slotKeys.size(); ++i) {
+        cpp_file << (i == 0 ? "" : ", ") << slotKeys[i];
+    }
+    cpp_file << "};\n";
+    cpp_file << "int displacement = displacements[registry_hash(key, 0u) % " << keys.size() << "u];\n";
+    cpp_file << "uint32_t slot = displacement < 0 ? uint32_t(-displacement - 1) : registry_hash(key, uint32_t(displacement)) % "
+             << keys.size() << "u;\n";
+    cpp_file << "if (strcmp(keys[slot], key) != 0) {\n";
+    cpp_file << "return nullptr;\n}\n";
+    cpp_file << "return &" << className << "_instances()[indices[slot]];\n}\n";
+}
+
+/*
+ * Static, perfect hashed lookup of every instance by name (and by keyField when given), one set per class.
+ * keyField has to be a string field of every instance of a class, classes without it get no key lookup,
+ * and at least one class has to have it.
+ */
+void generate_registry(const vector <GeneratedInstance> &instances, const string &keyField, ostream &header_file,
+                       ostream &cpp_file) {
+    cpp_file << "static uint32_t registry_hash(const char *key, uint32_t seed) {\n";
+    cpp_file << "uint32_t hash = 2166136261u ^ seed;\n";
+    cpp_file << "while (*key != '\\0') {\n";
+    cpp_file << "hash ^= (unsigned char) *key++;\n";
+    cpp_file << "hash *= 16777619u;\n}\n";
+    cpp_file << "hash ^= hash >> 16;\n";
+    cpp_file << "hash *= 0x85ebca6bu;\n";
+    cpp_file << "hash ^= hash >> 13;\n";
+    cpp_file << "hash *= 0xc2b2ae35u;\n";
+    cpp_file << "hash ^= hash >> 16;\n";
+    cpp_file << "return hash;\n}\n";
+
+    vector <string> classNames;
+    int keyedClasses = 0;
+    for (const GeneratedInstance &instance: instances) {
+        if (find(classNames.begin(), classNames.end(), instance.className) == classNames.end()) {
+            classNames.push_back(instance.className);
+        }
+    }
 
-    string outStr =
-            className + " " + inJsonValue.objectValue["Instance"].stringValue + " = " + className + "(" + objInstStr +
-            ");\n";
-    return outStr;
+    for (const string &className: classNames) {
+        vector <string> names;
+        vector <string> keys;
+        string missingKey;
+
+        /* built on first lookup, nothing runs at startup */
+        cpp_file << "static const " << className << " *" << className << "_instances() {\n";
+        cpp_file << "static const " << className << " instances[] = {";
+        for (const GeneratedInstance &instance: instances) {
+            if (instance.className != className) {
+                continue;
+            }
+            cpp_file << (names.empty() ? "" : ", ") << className << "(" << instance.arguments << ")";
+            names.push_back(instance.instanceName);
+
+            auto field = find_if(instance.fields.begin(), instance.fields.end(),
+                                 [&keyField](const pair <string, JSONValue> &f) { return f.first == keyField; });
+            if (field == instance.fields.end() || field->second.type != JSONValueType::String) {
+                missingKey = instance.instanceName;
+            } else {
+                keys.push_back(field->second.stringValue);
+            }
+        }
+        cpp_file << "};\n";
+        cpp_file << "return instances;\n}\n";
+
+        generate_lookup(className, "find_" + className, "instance name", names, header_file, cpp_file);
+
+        if (keyField.empty()) {
+            continue;
+        }
+        if (keys.empty()) {
+            cerr << "Class " << className << " has no string field " << keyField << ", no find_" << className
+                 << "_by_" << keyField << " generated\n";
+        } else if (!missingKey.empty()) {
+            throw invalid_argument("Instance " + missingKey + " of class " + className + " has no string field " +
+                                   keyField + ", cannot generate find_" + className + "_by_" + keyField);
+        } else {
+            generate_lookup(className, "find_" + className + "_by_" + keyField, keyField, keys, header_file,
+                            cpp_file);
+            keyedClasses++;
+        }
+    }
+    if (!keyField.empty() && keyedClasses == 0) {
+        throw invalid_argument("No class has a string field " + keyField + " to look up instances by");
+    }
 }
 
-void generate_file(const JSONValue &inJsonValue, ofstream &header_file, ofstream &cpp_file, const string &fileName) {
+void generate_file(const JSONValue &inJsonValue, ostream &header_file, ostream &cpp_file, const string &fileName,
+                   bool withRegistry, const string &keyField) {
     /* write to header file */
     string capFileName = fileName;
     transform(capFileName.begin(), capFileName.end(), capFileName.begin(), ::toupper);
@@ -303,18 +773,39 @@ void generate_file(const JSONValue &inJsonValue, ofstream &header_file, ofstream
 
     /* write to cpp file */
     cpp_file << "#include <iostream>\n";
+    if (withRegistry) {
+        cpp_file << "#include <cstdint>\n";
+        cpp_file << "#include <cstring>\n";
+    }
     cpp_file << "#include \"" << fileName << ".h\"\n";
     cpp_file << "using namespace std;\n";
 
-    string mainStr;
+    vector <GeneratedInstance> instances;
     if (inJsonValue.arrayValue.empty()) {
-        mainStr += generate_impl_file(inJsonValue, header_file, cpp_file);
+        instances.emplace_back();
+        collect_instance(inJsonValue, instances.back());
     } else {
         for (const JSONValue &parsedJsonValue: inJsonValue.arrayValue) {
-            mainStr += generate_impl_file(parsedJsonValue, header_file, cpp_file);
+            instances.emplace_back();
+            collect_instance(parsedJsonValue, instances.back());
         }
     }
 
+    /* a class that appears again only adds another instance */
+    for (const GeneratedClass &generatedClass: unify_classes(instances)) {
+        generate_impl_file(generatedClass, header_file, cpp_file);
+    }
+
+    string mainStr;
+    for (const GeneratedInstance &instance: instances) {
+        mainStr += instance.className + " " + instance.instanceName + " = " + instance.className + "(" +
+                   instance.arguments + ");\n";
+    }
+
+    if (withRegistry) {
+        generate_registry(instances, keyField, header_file, cpp_file);
+    }
+
     header_file << "#endif\n";
 
     cpp_file << "int main(int argc, char *argv[]) {\n";
@@ -323,22 +814,57 @@ void generate_file(const JSONValue &inJsonValue, ofstream &header_file, ofstream
 }
 
 
-int main() {
+/* Contents of name.json, name.json.gz or name.json.zst, whichever exists first */
+string read_input(const string &fileName) {
+    string jsonString;
+    for (const char *extension: {".json", ".json.gz", ".json.zst"}) {
+        FILE *inJsonFile = open_input((fileName + extension).c_str());
+        if (inJsonFile == nullptr) {
+            continue;
+        }
+        char buffer[1 << 16];
+        size_t length;
+        while ((length = fread(buffer, 1, sizeof(buffer), inJsonFile)) > 0) {
+            jsonString.append(buffer, length);
+        }
+        if (close_stream(inJsonFile) != 0) {
+            throw runtime_error("Failed to decompress " + fileName + extension);
+        }
+        break;
+    }
+    return jsonString;
+}
+
+#ifndef PIPELINE
+/* ./part2 [-r [key_field]], -r also emits a static lookup of instances by name (and key_field) */
+int main(int argc, char *argv[]) {
+    bool withRegistry = argc >= 2 && string(argv[1]) == "-r";
+    string keyField = (withRegistry && argc >= 3) ? argv[2] : "";
     string fileName;
     cout << "Input file name (without .json): ";
     cin >> fileName;
-    ifstream inJsonFile(fileName + ".json");
-    string jsonString((istreambuf_iterator<char>(inJsonFile)), istreambuf_iterator<char>());
-
+    JSONValue parsedJsonValue;
     try {
-        JSONParser parser(jsonString);
-        JSONValue parsedJsonValue = parser.parse();
-        ofstream header_file(fileName + ".h");
-        ofstream cpp_file(fileName + ".cpp");
-        generate_file(parsedJsonValue, header_file, cpp_file, fileName);
+        string jsonString = read_input(fileName);
+        JSONParser parser(jsonString, is_generator_key);
+        parsedJsonValue = parser.parse();
     } catch (const exception &e) {
         cerr << "Failed to parse JSON string: " << e.what() << endl;
+        return 0;
     }
 
+    /* generate in memory first, so an error leaves no half written files */
+    ostringstream header_file;
+    ostringstream cpp_file;
+    try {
+        generate_file(parsedJsonValue, header_file, cpp_file, fileName, withRegistry, keyField);
+    } catch (const exception &e) {
+        cerr << "Failed to generate classes: " << e.what() << endl;
+        return 0;
+    }
+    ofstream(fileName + ".h") << header_file.str();
+    ofstream(fileName + ".cpp") << cpp_file.str();
+
     return 0;
-}
\ No newline at end of file
+}
+#endif
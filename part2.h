@@ -6,9 +6,13 @@
 #include <iostream>
 #include <unordered_map>
 #include <fstream>
+#include <sstream>
 #include <vector>
 #include <cmath>
 #include <algorithm>
+#include <charconv>
+#include <climits>
+#include <cstdint>
 
 using namespace std;
 enum class JSONValueType {
@@ -20,6 +24,39 @@ enum class JSONValueType {
     Object
 };
 
+class JSONValue;
+
+/* JSON object that keeps members in source order, hashed lookup is only built for large objects */
+class JSONObject {
+public:
+    typedef std::pair <std::string, JSONValue> Member;
+
+    JSONValue &operator[](const std::string &key);
+
+    const JSONValue &operator[](const std::string &key) const;
+
+    const JSONValue *find(const std::string &key) const;
+
+    bool emplace(std::string key, JSONValue value);
+
+    size_t size() const { return members.size(); }
+
+    bool empty() const { return members.empty(); }
+
+    std::vector<Member>::const_iterator begin() const { return members.begin(); }
+
+    std::vector<Member>::const_iterator end() const { return members.end(); }
+
+private:
+    /* below this many members a linear scan beats hashing the key */
+    static const size_t indexThreshold = 16;
+
+    std::vector <Member> members;
+    std::unordered_map <std::string, size_t> index;
+
+    size_t lookup(const std::string &key) const;
+};
+
 class JSONValue {
 public:
     JSONValueType type;
@@ -30,29 +67,39 @@ public:
 
     JSONValue(double value) : type(JSONValueType::Number), numberValue(value) {}
 
+    JSONValue(long long value) : type(JSONValueType::Number), numberValue(double(value)), isInteger(true),
+                                 integerValue(value) {}
+
     JSONValue(std::string value) : type(JSONValueType::String), stringValue(std::move(value)) {}
 
-    JSONValue(const std::vector <JSONValue> &value) : type(JSONValueType::Array), arrayValue(value) {}
+    JSONValue(std::vector <JSONValue> value) : type(JSONValueType::Array), arrayValue(std::move(value)) {}
 
-    JSONValue(const std::unordered_map <std::string, JSONValue> &value) : type(JSONValueType::Object),
-                                                                          objectValue(value) {}
+    JSONValue(JSONObject value) : type(JSONValueType::Object), objectValue(std::move(value)) {}
 
     bool booleanValue{};
     double numberValue{};
+    /* number was written without fraction or exponent and fits in a long long */
+    bool isInteger{};
+    long long integerValue{};
     std::string stringValue;
     std::vector <JSONValue> arrayValue;
-    std::unordered_map <std::string, JSONValue> objectValue;
+    JSONObject objectValue;
 };
 
+/* Decides whether an object member is decoded, nullptr keeps every member */
+typedef bool (*KeyFilter)(const std::string &key);
+
 class JSONParser {
 public:
-    explicit JSONParser(std::string jsonString) : jsonString(std::move(jsonString)), index(0) {}
+    explicit JSONParser(std::string jsonString, KeyFilter keyFilter = nullptr) : jsonString(std::move(jsonString)),
+                                                                               index(0), keyFilter(keyFilter) {}
 
     JSONValue parse();
 
 private:
     std::string jsonString;
     size_t index;
+    KeyFilter keyFilter;
 
     void skipWhiteSpace();
 
@@ -62,16 +109,61 @@ private:
 
     std::string parseString();
 
-    double parseNumber();
+    JSONValue parseNumber();
 
     std::vector <JSONValue> parseArray();
 
-    std::unordered_map <std::string, JSONValue> parseObject();
+    JSONObject parseObject();
+
+    void skipString();
+
+    void skipValue();
+};
+
+bool is_generator_key(const std::string &key);
+
+std::string cpp_string_literal(const std::string &s);
+
+bool fits_float(double value);
+
+std::string shortest_float_literal(double value, bool asFloat);
+
+/* One instance from the JSON, fields in source order */
+struct GeneratedInstance {
+    std::string className;
+    std::string instanceName;
+    std::vector <std::pair<std::string, JSONValue>> fields;
+    /* constructor arguments, filled in by unify_classes */
+    std::string arguments;
+};
+
+/* A class with its (field, C++ type) pairs, shared by all of its instances */
+struct GeneratedClass {
+    std::string name;
+    std::vector <std::pair<std::string, std::string>> fields;
 };
 
-string generate_impl_file(JSONValue inJsonValue, ofstream &header_file, ofstream &cpp_file);
+string field_type(const JSONValue &value);
+
+string field_literal(const JSONValue &value, const string &typeName);
+
+void collect_instance(const JSONValue &inJsonValue, GeneratedInstance &instance);
+
+vector <GeneratedClass> unify_classes(vector <GeneratedInstance> &instances);
+
+void generate_impl_file(const GeneratedClass &generatedClass, ostream &header_file, ostream &cpp_file);
+
+uint32_t registry_hash(const string &key, uint32_t seed);
+
+void build_perfect_hash(const vector <string> &keys, vector<int> &displacements, vector<int> &slotKeys);
+
+void generate_registry(const vector <GeneratedInstance> &instances, const string &keyField, ostream &header_file,
+                       ostream &cpp_file);
+
+void generate_file(const JSONValue &inJsonValue, ostream &header_file, ostream &cpp_file, const string &fileName,
+                   bool withRegistry = false, const string &keyField = "");
 
-void generate_file(const JSONValue &inJsonValue, ofstream &header_file, ofstream &cpp_file, const string &fileName);
+string read_input(const string &fileName);
 
 #endif
 
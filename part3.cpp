@@ -6,6 +6,7 @@
 #include <cmath>
 #include <algorithm>
 #include <regex>
+#include <sstream>
 #include "part3.h"
 
 using namespace std;
@@ -34,24 +35,58 @@ string removeWhitespace(const string &str) {
 }
 
 
-vector<string> getClassNames(string className) {
+vector<string> getClassNamesFromHeader(const string &headerString) {
     vector<string> classNames;
     string line;
-    ifstream file(className+".h");
-    if (file.is_open()) {
-        while (getline(file, line)) {
-            smatch match;
-            regex classRegex("class\\s+(\\w+)\\s*\\{");
-            if (regex_search(line, match, classRegex)) {
-                classNames.push_back(match[1].str());
-            }
+    istringstream header(headerString);
+    regex classRegex("class\\s+(\\w+)\\s*\\{");
+    while (getline(header, line)) {
+        smatch match;
+        if (regex_search(line, match, classRegex)) {
+            classNames.push_back(match[1].str());
         }
-        file.close();
     }
     return classNames;
 }
 
-void editHeader(string fileName,vector<string> classNames,
+vector<string> getClassNames(string className) {
+    ifstream file(className+".h");
+    string headerString((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+    return getClassNamesFromHeader(headerString);
+}
+
+void parseMethodFile(const string &txtString,
+                vector<string> &classStrings,
+                vector<string> &visStrings,
+                vector<string> &returnTypeStrings,
+                vector<string> &mtdNameStrings,
+                vector<string> &mtdImplStrings) {
+    vector<string> splitStrings = split(txtString, "######\n");
+    splitStrings.erase(splitStrings.begin());
+    for (int i = 0; i < splitStrings.size(); i += 2) {
+        string classVisString = splitStrings[i];
+        vector<string> classVisStrings = split(classVisString, " -");
+        string className = removeWhitespace(classVisStrings[0]);
+        string visibility = removeWhitespace(classVisStrings[1]);
+        classStrings.push_back(className);
+        visStrings.push_back(visibility);
+    }
+    for (int i = 1; i < splitStrings.size(); i += 2) {
+        string retTypeMtdNameImplString = splitStrings[i];
+        unsigned long splitIdx = retTypeMtdNameImplString.find('{');
+        string retTypeMtdNameString = removeWhitespace(retTypeMtdNameImplString.substr(0, splitIdx));
+        string mtdImplString = removeWhitespace(retTypeMtdNameImplString.substr(splitIdx));
+        /* separate return type and method name */
+        unsigned long splitIdx2 = retTypeMtdNameString.find(' ');
+        string returnType = retTypeMtdNameString.substr(0, splitIdx2);
+        string methodName = removeWhitespace(retTypeMtdNameString.substr(splitIdx2));
+        returnTypeStrings.push_back(returnType);
+        mtdNameStrings.push_back(methodName);
+        mtdImplStrings.push_back(mtdImplString);
+    }
+}
+
+string addMethodsToHeader(string headerString,const vector<string> &classNames,
                 const vector<string> &classStrings,
                 const vector<string> &visStrings,
                 const vector<string> &returnTypeStrings,
@@ -59,8 +94,6 @@ void editHeader(string fileName,vector<string> classNames,
                 const vector<string> &mtdImplStrings) {
     
     for (int j=0; j<classNames.size(); j++){
-        ifstream inHeaderFile(fileName + ".h");
-        string headerString((istreambuf_iterator<char>(inHeaderFile)), istreambuf_iterator<char>());
         string newHeaderString;
         string className = classNames[j];
 
@@ -109,19 +142,12 @@ void editHeader(string fileName,vector<string> classNames,
         string splitProtectpart2 = splitPublicpart2.substr(splitProtectIdx+10);
         newHeaderString = newHeaderString+splitProtectpart1+"\n"+protectedMtdStr+splitProtectpart2;
 
-        /* 5. clear origin content*/
-        ofstream file(fileName + ".h", ios::trunc);
-
-        /* 6. add new string*/
-        ofstream header_file(fileName + ".h");
-        header_file<< newHeaderString;
-        
+        headerString = newHeaderString;
     }
-    
-
+    return headerString;
 }
 
-void editCpp(string fileName,vector<string> classNames,
+string addMethodsToCpp(string cppString,const vector<string> &classNames,
                 const vector<string> &classStrings,
                 const vector<string> &visStrings,
                 const vector<string> &returnTypeStrings,
@@ -129,8 +155,6 @@ void editCpp(string fileName,vector<string> classNames,
                 const vector<string> &mtdImplStrings){
 
     for (int i=0; i<classNames.size(); i++){
-        ifstream inCppFile(fileName + ".cpp");
-        string cppString((istreambuf_iterator<char>(inCppFile)), istreambuf_iterator<char>());
         string newcppString;
         string className = classNames[i];
 
@@ -152,16 +176,43 @@ void editCpp(string fileName,vector<string> classNames,
         string splitCpppart2 = cppString.substr(splitClassNameIdx);
         newcppString = splitCpppart1+"\n"+cppMtdStr+"\n"+splitCpppart2;
 
-        /* 2. clear origin content*/
-        ofstream file(fileName + ".cpp", ios::trunc);
-
-        /* 3. add new string*/
-        ofstream cpp_file(fileName + ".cpp");
-        cpp_file<< newcppString;
+        cppString = newcppString;
     }
+    return cppString;
+}
 
+void editHeader(string fileName,vector<string> classNames,
+                const vector<string> &classStrings,
+                const vector<string> &visStrings,
+                const vector<string> &returnTypeStrings,
+                const vector<string> &mtdNameStrings,
+                const vector<string> &mtdImplStrings) {
+    ifstream inHeaderFile(fileName + ".h");
+    string headerString((istreambuf_iterator<char>(inHeaderFile)), istreambuf_iterator<char>());
+    inHeaderFile.close();
+
+    /* read once, edit every class in memory, write once */
+    ofstream header_file(fileName + ".h", ios::trunc);
+    header_file << addMethodsToHeader(headerString, classNames,
+                classStrings, visStrings, returnTypeStrings, mtdNameStrings, mtdImplStrings);
 }
 
+void editCpp(string fileName,vector<string> classNames,
+                const vector<string> &classStrings,
+                const vector<string> &visStrings,
+                const vector<string> &returnTypeStrings,
+                const vector<string> &mtdNameStrings,
+                const vector<string> &mtdImplStrings){
+    ifstream inCppFile(fileName + ".cpp");
+    string cppString((istreambuf_iterator<char>(inCppFile)), istreambuf_iterator<char>());
+    inCppFile.close();
+
+    ofstream cpp_file(fileName + ".cpp", ios::trunc);
+    cpp_file << addMethodsToCpp(cppString, classNames,
+                classStrings, visStrings, returnTypeStrings, mtdNameStrings, mtdImplStrings);
+}
+
+#ifndef PIPELINE
 int main() {
     string fileName;
     cout << "Input file name (without .json): ";
@@ -169,34 +220,13 @@ int main() {
     ifstream inTxtFile(fileName + ".txt");
     string txtString((istreambuf_iterator<char>(inTxtFile)), istreambuf_iterator<char>());
 
-    vector<string> splitStrings = split(txtString, "######\n");
-    splitStrings.erase(splitStrings.begin());
     vector<string> classStrings;
     vector<string> visStrings;
     vector<string> returnTypeStrings;
     vector<string> mtdNameStrings;
     vector<string> mtdImplStrings;
-    for (int i = 0; i < splitStrings.size(); i += 2) {
-        string classVisString = splitStrings[i];
-        vector<string> classVisStrings = split(classVisString, " -");
-        string className = removeWhitespace(classVisStrings[0]);
-        string visibility = removeWhitespace(classVisStrings[1]);
-        classStrings.push_back(className);
-        visStrings.push_back(visibility);
-    }
-    for (int i = 1; i < splitStrings.size(); i += 2) {
-        string retTypeMtdNameImplString = splitStrings[i];
-        unsigned long splitIdx = retTypeMtdNameImplString.find('{');
-        string retTypeMtdNameString = removeWhitespace(retTypeMtdNameImplString.substr(0, splitIdx));
-        string mtdImplString = removeWhitespace(retTypeMtdNameImplString.substr(splitIdx));
-        /* separate return type and method name */
-        unsigned long splitIdx2 = retTypeMtdNameString.find(' ');
-        string returnType = retTypeMtdNameString.substr(0, splitIdx2);
-        string methodName = removeWhitespace(retTypeMtdNameString.substr(splitIdx2));
-        returnTypeStrings.push_back(returnType);
-        mtdNameStrings.push_back(methodName);
-        mtdImplStrings.push_back(mtdImplString);
-    }
+    parseMethodFile(txtString,
+                classStrings, visStrings, returnTypeStrings, mtdNameStrings, mtdImplStrings);
     
     vector<string> classNames = getClassNames(fileName);
     editHeader(fileName,classNames,
@@ -204,4 +234,5 @@ int main() {
     editCpp(fileName,classNames,
                 classStrings, visStrings, returnTypeStrings, mtdNameStrings, mtdImplStrings);
     return 0;
-}
\ No newline at end of file
+}
+#endif
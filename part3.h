@@ -9,10 +9,30 @@
 #include <cmath>
 #include <algorithm>
 #include <regex>
+#include <sstream>
 
 std::vector<std::string> split(std::string s, const std::string& delimiter);
 std::string removeWhitespace(const std::string &str);
+std::vector<std::string> getClassNamesFromHeader(const std::string &headerString);
 std::vector<std::string> getClassNames(std::string className);
+void parseMethodFile(const std::string &txtString,
+                std::vector<std::string> &classStrings,
+                std::vector<std::string> &visStrings,
+                std::vector<std::string> &returnTypeStrings,
+                std::vector<std::string> &mtdNameStrings,
+                std::vector<std::string> &mtdImplStrings);
+std::string addMethodsToHeader(std::string headerString,const std::vector<std::string> &classNames,
+                const std::vector<std::string> &classStrings,
+                const std::vector<std::string> &visStrings,
+                const std::vector<std::string> &returnTypeStrings,
+                const std::vector<std::string> &mtdNameStrings,
+                const std::vector<std::string> &mtdImplStrings);
+std::string addMethodsToCpp(std::string cppString,const std::vector<std::string> &classNames,
+                const std::vector<std::string> &classStrings,
+                const std::vector<std::string> &visStrings,
+                const std::vector<std::string> &returnTypeStrings,
+                const std::vector<std::string> &mtdNameStrings,
+                const std::vector<std::string> &mtdImplStrings);
 void editHeader(std::string fileName,std::vector<std::string> classNames,
                 const std::vector<std::string> &classStrings,
                 const std::vector<std::string> &visStrings,
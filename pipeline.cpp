@@ -0,0 +1,136 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <charconv>
+#include <cctype>
+#include <cstring>
+#include "part1.h"
+#include "part2.h"
+#include "part3.h"
+#include "compress_io.h"
+
+using namespace std;
+
+/* Typed cell straight into the JSON model, no JSON text in between */
+JSONValue cell_to_json(const char *cell, ColType type) {
+    const char *last = cell + strlen(cell);
+    if (type != COL_STRING && cell == last) {
+        /* missing value */
+        return {};
+    } else if (type == COL_BOOL) {
+        return {tolower((unsigned char) cell[0]) == 't'};
+    } else if (type == COL_INT) {
+        long long integerValue = 0;
+        from_chars(cell, last, integerValue);
+        return {integerValue};
+    } else if (type == COL_FLOAT) {
+        double numberValue = 0;
+        from_chars(cell, last, numberValue);
+        return {numberValue};
+    }
+    return {string(cell)};
+}
+
+/*
+ * One object per row. A ValueN column holds values of different fields of different classes, so each
+ * value is typed on its own instead of by its column, and an empty FieldN drops its ValueN partner
+ * (rows of classes with fewer fields than the widest one).
+ */
+JSONValue rows_to_json(char **col_names, CsvRow **rows) {
+    vector <JSONValue> objects;
+    objects.reserve(num_lines);
+    for (int i = 0; i < num_lines; i++) {
+        JSONObject object;
+        vector <string> skipped;
+        for (int j = 0; j < num_columns; j++) {
+            if (strncmp(col_names[j], "Field", 5) == 0 && rows[i]->csv_data[j * 2 + 1][0] == '\0') {
+                skipped.push_back(string("Value") + (col_names[j] + 5));
+            }
+        }
+        for (int j = 0; j < num_columns; j++) {
+            const char *cell = rows[i]->csv_data[j * 2 + 1];
+            if (strncmp(col_names[j], "Field", 5) == 0 && cell[0] == '\0') {
+                continue;
+            }
+            if (strncmp(col_names[j], "Value", 5) == 0) {
+                if (find(skipped.begin(), skipped.end(), col_names[j]) == skipped.end()) {
+                    object.emplace(col_names[j], cell_to_json(cell, classify_cell(cell)));
+                }
+            } else {
+                object.emplace(col_names[j], cell_to_json(cell, COL_STRING));
+            }
+        }
+        objects.emplace_back(std::move(object));
+    }
+    return {std::move(objects)};
+}
+
+/* part1 -> part2 -> part3 in one process, only the final .h and .cpp touch the disk */
+int main(int argc, char *argv[]) {
+    if (argc != 3) {
+        cout << "Input Format: pipeline input_file.csv output_name\n";
+        return 0;
+    }
+    string fileName = argv[2];
+
+    /* part 1: CSV rows, the cells are typed one by one in rows_to_json */
+    FILE *csv_file = open_input(argv[1]);
+    if (csv_file == nullptr) {
+        cout << "Wrong input file name\n";
+        return 0;
+    }
+    char **col_names;
+    CsvRow **rows = read_csv(csv_file, &col_names, ',');
+    if (close_stream(csv_file) != 0) {
+        cerr << "Failed to decompress " << argv[1] << endl;
+        free_csv(col_names, rows);
+        return 1;
+    }
+    if (rows == nullptr) {
+        return 1;
+    }
+    if (num_lines == 0) {
+        cerr << "No rows in " << argv[1] << endl;
+        free_csv(col_names, rows);
+        return 0;
+    }
+    JSONValue jsonValue = rows_to_json(col_names, rows);
+    free_csv(col_names, rows);
+
+    /* part 2: generate into memory */
+    ostringstream header_file;
+    ostringstream cpp_file;
+    try {
+        generate_file(jsonValue, header_file, cpp_file, fileName);
+    } catch (const exception &e) {
+        cerr << "Failed to generate classes: " << e.what() << endl;
+        return 1;
+    }
+    string headerString = header_file.str();
+    string cppString = cpp_file.str();
+
+    /* part 3: methods from <output_name>.txt, if there is one */
+    ifstream inTxtFile(fileName + ".txt");
+    if (inTxtFile.is_open()) {
+        string txtString((istreambuf_iterator<char>(inTxtFile)), istreambuf_iterator<char>());
+        vector<string> classStrings;
+        vector<string> visStrings;
+        vector<string> returnTypeStrings;
+        vector<string> mtdNameStrings;
+        vector<string> mtdImplStrings;
+        parseMethodFile(txtString,
+                classStrings, visStrings, returnTypeStrings, mtdNameStrings, mtdImplStrings);
+        vector<string> classNames = getClassNamesFromHeader(headerString);
+        headerString = addMethodsToHeader(headerString, classNames,
+                classStrings, visStrings, returnTypeStrings, mtdNameStrings, mtdImplStrings);
+        cppString = addMethodsToCpp(cppString, classNames,
+                classStrings, visStrings, returnTypeStrings, mtdNameStrings, mtdImplStrings);
+    }
+
+    ofstream(fileName + ".h") << headerString;
+    ofstream(fileName + ".cpp") << cppString;
+    return 0;
+}
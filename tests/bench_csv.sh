@@ -0,0 +1,48 @@
+#!/bin/sh
+# Reproducible part1 throughput benchmark: generates the same CSV every run
+# (ROWS rows of mixed int / float / bool / quoted string columns), converts it
+# RUNS times to JSON and to the columnar layout and reports the best time.
+# Run from the repository root after make, as done by make bench.
+#   ROWS=200000 RUNS=5 sh tests/bench_csv.sh
+
+ROOT=$(pwd)
+ROWS=${ROWS:-200000}
+RUNS=${RUNS:-5}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+awk -v rows="$ROWS" 'BEGIN {
+    srand(42)
+    print "id,price,active,name,comment"
+    for (i = 0; i < rows; i++) {
+        printf "%d,%.2f,%s,name%d,\"text, with \"\"quotes\"\" %d\"\n", i, rand() * 1000, (i % 3 == 0) ? "true" : "false", i % 977, int(rand() * 100000)
+    }
+}' > "$WORK/bench.csv"
+bytes=$(wc -c < "$WORK/bench.csv")
+echo "input: $ROWS rows, $bytes bytes, best of $RUNS runs"
+
+now_ns() {
+    date +%s%N
+}
+
+bench() {
+    label=$1
+    shift
+    best=""
+    run=0
+    while [ "$run" -lt "$RUNS" ]; do
+        start=$(now_ns)
+        "$ROOT/part1" "$@" "$WORK/bench.csv" "$WORK/out" > /dev/null || exit 1
+        elapsed=$(( $(now_ns) - start ))
+        if [ -z "$best" ] || [ "$elapsed" -lt "$best" ]; then
+            best=$elapsed
+        fi
+        run=$((run + 1))
+    done
+    awk -v label="$label" -v ns="$best" -v bytes="$bytes" 'BEGIN {
+        printf "%-10s %8.1f ms %8.1f MB/s\n", label, ns / 1e6, bytes / 1e6 / (ns / 1e9)
+    }'
+}
+
+bench json
+bench columnar -b
@@ -0,0 +1,46 @@
+#!/bin/sh
+# CSV conformance corpus for part1. For every tests/csv/NAME.csv:
+#   NAME.args  optional part1 options (e.g. -d ;)
+#   NAME.json  expected output; when missing part1 must fail and write nothing
+#   NAME.err   expected stderr (warnings / errors); when missing stderr must be empty
+# Run from the repository root after make, as done by make check.
+
+ROOT=$(pwd)
+CORPUS="$ROOT/tests/csv"
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+failures=0
+cases=0
+
+fail() {
+    echo "FAIL: $1"
+    failures=$((failures + 1))
+}
+
+for input in "$CORPUS"/*.csv; do
+    name=$(basename "$input" .csv)
+    cases=$((cases + 1))
+    args=""
+    [ -f "$CORPUS/$name.args" ] && args=$(cat "$CORPUS/$name.args")
+    # args is split into words on purpose
+    "$ROOT/part1" $args "$input" "$WORK/$name.json" > /dev/null 2> "$WORK/$name.err"
+    status=$?
+    if [ -f "$CORPUS/$name.json" ]; then
+        [ "$status" -eq 0 ] || fail "$name: exit status $status"
+        cmp -s "$CORPUS/$name.json" "$WORK/$name.json" || fail "$name: output differs from $name.json"
+    else
+        [ "$status" -ne 0 ] || fail "$name: expected a failure"
+        [ -e "$WORK/$name.json" ] && fail "$name: output written for a failed run"
+    fi
+    if [ -f "$CORPUS/$name.err" ]; then
+        cmp -s "$CORPUS/$name.err" "$WORK/$name.err" || fail "$name: stderr differs from $name.err"
+    elif [ -s "$WORK/$name.err" ]; then
+        fail "$name: unexpected stderr: $(cat "$WORK/$name.err")"
+    fi
+done
+
+if [ "$failures" -ne 0 ]; then
+    echo "csv conformance: $failures failure(s) in $cases case(s)"
+    exit 1
+fi
+echo "csv conformance: $cases case(s) ok"
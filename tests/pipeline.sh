@@ -0,0 +1,53 @@
+#!/bin/sh
+# pipeline on Class / Instance / FieldN / ValueN CSVs: classes with fewer fields
+# than the widest one, values typed per cell, and the generated code compiles.
+# Run from the repository root after make, as done by make check.
+
+ROOT=$(pwd)
+CXX=${CXX:-g++}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+failures=0
+
+fail() {
+    echo "FAIL: $1"
+    failures=$((failures + 1))
+}
+
+compiles() {
+    "$CXX" -c "$1.cpp" -o "$1.o" > /dev/null 2>&1
+}
+
+cd "$WORK" || exit 1
+
+# Prof has one field less, its Field2 / Value2 cells are empty
+printf 'Class,Instance,Field1,Value1,Field2,Value2\nStudent,s1,name,John,major,CS\nProf,p1,name,Tan,,\n' > short.csv
+"$ROOT/pipeline" short.csv short > /dev/null || fail "pipeline on a class with fewer fields"
+grep -q 'Prof(string name);' short.h || fail "empty FieldN / ValueN cells became a field of Prof"
+compiles short || fail "generated code for a class with fewer fields does not compile"
+
+# the same with a numeric Value2 column
+printf 'Class,Instance,Field1,Value1,Field2,Value2\nStudent,s1,name,John,age,20\nProf,p1,name,Tan,,\n' > short_number.csv
+"$ROOT/pipeline" short_number.csv short_number > /dev/null || fail "pipeline with an empty numeric ValueN cell"
+compiles short_number || fail "generated code with an empty numeric ValueN cell does not compile"
+
+# Value2 holds an int of Student and floats / strings of other classes
+printf 'Class,Instance,Field1,Value1,Field2,Value2\nStudent,s1,name,John,age,20\nProf,p1,title,Dr,rating,8.5\nRoom,r1,name,A1,wing,east\n' > mixed.csv
+"$ROOT/pipeline" mixed.csv mixed > /dev/null || fail "pipeline with mixed ValueN column"
+grep -q 'Student(string name, int age);' mixed.h || fail "Student.age is not typed from its own value"
+grep -q 'Prof(string title, float rating);' mixed.h || fail "Prof.rating is not typed from its own value"
+grep -q 'Student("John", 20)' mixed.cpp || fail "Student.age literal is not an int"
+compiles mixed || fail "generated code for a mixed ValueN column does not compile"
+
+# a generation error has to be visible to scripts
+printf 'Class,Instance,Field1,Value1\nStudent,s1,age,20\nStudent,s2,age,old\n' > conflict.csv
+if "$ROOT/pipeline" conflict.csv conflict > /dev/null 2>&1; then
+    fail "pipeline exits 0 when generation fails"
+fi
+[ -e conflict.h ] && fail "pipeline wrote output for a failed generation"
+
+if [ "$failures" -ne 0 ]; then
+    echo "pipeline: $failures failure(s)"
+    exit 1
+fi
+echo "pipeline: ok"
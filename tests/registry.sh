@@ -0,0 +1,55 @@
+#!/bin/sh
+# part2 -r: the generated registry compiles and finds every instance, and a
+# key field or instance names that cannot be looked up are reported.
+# Run from the repository root after make, as done by make check.
+
+ROOT=$(pwd)
+CXX=${CXX:-g++}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+failures=0
+
+fail() {
+    echo "FAIL: $1"
+    failures=$((failures + 1))
+}
+
+cd "$WORK" || exit 1
+cp "$ROOT/student.json" .
+
+# lookups by name and by title (a field of Professor only)
+echo student | "$ROOT/part2" -r title > /dev/null 2> title.err || fail "part2 -r title"
+grep -q 'find_Professor_by_title' student.h || fail "no find_Professor_by_title"
+grep -q 'Student has no string field title' title.err || fail "no warning for Student without title"
+cat > main.cpp <<'MAIN'
+#include "student.h"
+int main() {
+    return find_Student("s1") != nullptr && find_Professor("p1") != nullptr && find_Student("p1") == nullptr &&
+           find_Professor_by_title("Associate Prof") != nullptr ? 0 : 1;
+}
+MAIN
+# student.cpp has its own main() printing the instances
+if "$CXX" -c student.cpp -Dmain=student_main -o student.o > /dev/null 2>&1 &&
+   "$CXX" main.cpp student.o -o lookup > /dev/null 2>&1; then
+    ./lookup || fail "generated lookups do not find the instances"
+else
+    fail "generated registry does not compile"
+fi
+rm -f student.h student.cpp
+
+# a key field no class has
+echo student | "$ROOT/part2" -r nonexistent > /dev/null 2> missing.err
+grep -q 'No class has a string field nonexistent' missing.err || fail "-r nonexistent is not reported"
+[ -e student.h ] && fail "part2 wrote output for -r nonexistent"
+
+# duplicate instance names
+printf '[{"Class":"A","Instance":"a","Field1":"k","Value1":"x"},{"Class":"A","Instance":"a","Field1":"k","Value1":"y"}]' > dup.json
+echo dup | "$ROOT/part2" -r > /dev/null 2> dup.err
+grep -q 'Duplicate instance name "a" in A' dup.err || fail "duplicate instance names are not reported"
+[ -e dup.h ] && fail "part2 wrote output for duplicate instance names"
+
+if [ "$failures" -ne 0 ]; then
+    echo "registry: $failures failure(s)"
+    exit 1
+fi
+echo "registry: ok"
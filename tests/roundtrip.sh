@@ -0,0 +1,85 @@
+#!/bin/sh
+# Round trip of part1 / part2 through gzip and zstd: output from compressed
+# input (and compressed output) has to match the plain run byte for byte.
+# Run from the repository root after make, as done by make check.
+
+ROOT=$(pwd)
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+failures=0
+
+fail() {
+    echo "FAIL: $1"
+    failures=$((failures + 1))
+}
+
+formats="gz"
+if command -v zstd > /dev/null 2>&1; then
+    formats="gz zst"
+else
+    echo "zstd not installed, only checking gzip"
+fi
+
+compress() {
+    case "$1" in
+        gz) gzip -c ;;
+        zst) zstd -cq ;;
+    esac
+}
+
+decompress() {
+    case "$1" in
+        gz) gzip -dc ;;
+        zst) zstd -dcq ;;
+    esac
+}
+
+# part1: JSON and columnar output
+cd "$WORK" || exit 1
+cp "$ROOT/part1_sample_input.csv" in.csv
+"$ROOT/part1" in.csv plain.json || fail "part1 plain json"
+"$ROOT/part1" -b in.csv plain.bin || fail "part1 plain columnar"
+for format in $formats; do
+    compress "$format" < in.csv > "in.csv.$format"
+    "$ROOT/part1" "in.csv.$format" "from_$format.json" || fail "part1 reading .$format"
+    cmp -s plain.json "from_$format.json" || fail "part1 json from .$format input"
+    "$ROOT/part1" in.csv "out.json.$format" || fail "part1 writing .$format"
+    decompress "$format" < "out.json.$format" | cmp -s plain.json - || fail "part1 json to .$format output"
+    "$ROOT/part1" -b "in.csv.$format" "out.bin.$format" || fail "part1 columnar .$format"
+    decompress "$format" < "out.bin.$format" | cmp -s plain.bin - || fail "part1 columnar through .$format"
+done
+
+# a broken archive must fail without leaving an output file
+printf '\037\213 not really gzip' > broken.csv
+if "$ROOT/part1" broken.csv broken.json > /dev/null 2>&1; then
+    fail "part1 exits 0 on a broken archive"
+fi
+[ -e broken.json ] && fail "part1 wrote output for a broken archive"
+
+# compressed output that cannot be written has to fail, not die of SIGPIPE
+"$ROOT/part1" in.csv missing/dir/out.json.gz > /dev/null 2>&1
+status=$?
+[ "$status" -eq 1 ] || fail "part1 exits $status for an output directory that does not exist"
+mkdir fake_bin
+printf '#!/bin/sh\nexit 1\n' > fake_bin/gzip
+chmod +x fake_bin/gzip
+PATH="$WORK/fake_bin:$PATH" "$ROOT/part1" in.csv failed.json.gz > /dev/null 2>&1
+status=$?
+[ "$status" -eq 1 ] || fail "part1 exits $status when the compressor fails"
+
+# part2: the same generated code from student.json, .json.gz and .json.zst
+mkdir plain && cp "$ROOT/student.json" plain/
+(cd plain && echo student | "$ROOT/part2" > /dev/null) || fail "part2 plain"
+for format in $formats; do
+    mkdir "$format"
+    compress "$format" < "$ROOT/student.json" > "$format/student.json.$format"
+    (cd "$format" && echo student | "$ROOT/part2" > /dev/null) || fail "part2 reading .$format"
+    cmp -s plain/student.h "$format/student.h" || fail "part2 header from .json.$format"
+    cmp -s plain/student.cpp "$format/student.cpp" || fail "part2 source from .json.$format"
+done
+
+if [ "$failures" -ne 0 ]; then
+    echo "roundtrip: $failures failure(s)"
+    exit 1
+fi
+echo "roundtrip: ok"